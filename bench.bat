@@ -0,0 +1,3 @@
+@echo off
+
+call build\nether_benchmark.exe
@@ -1,13 +1,21 @@
 
 local s32 Main(void)
 {
+#if NETHER_BENCHMARK
+    RunBenchmarks();
+#else
     u32 TestCount = 0;
 
     // NOTE(vak): Basic
     {
+        TestWires();
+        TestStorage();
+        TestRandom();
+        TestCircuits();
         TestBUF();
         TestTriState();
         TestLogicGates();
+        TestNativeGates();
     }
 
     PrintNewLine();
@@ -34,6 +42,7 @@ local s32 Main(void)
     {
         TestDLatch();
         TestDFlipFlop();
+        TestNativeMemory();
     }
 
     PrintNewLine();
@@ -42,7 +51,43 @@ local s32 Main(void)
     {
         TestRegister();
         TestALU();
+        TestWordGates();
+        TestRAM256();
+        TestModules();
     }
 
+    PrintNewLine();
+
+    // NOTE(vak): Lanes
+    {
+        TestLaneKernels();
+        TestExhaustive();
+    }
+
+    PrintNewLine();
+
+    // NOTE(vak): Engines
+    {
+        TestSimulationEngines();
+        TestUntilStable();
+        TestOptimizer();
+    }
+
+    PrintNewLine();
+
+    // NOTE(vak): Tools
+    {
+        TestTrace();
+        TestSnapshot();
+        TestNetlist();
+        TestImport();
+
+#if NETHER_COUNTERS
+        TestCounters();
+#endif
+    }
+
+#endif
+
     return (0);
 }
@@ -0,0 +1,363 @@
+// NOTE(vak): Workloads
+
+typedef struct
+{
+    wires   Inputs[3]; // NOTE(vak): Randomized before every pass or cycle
+    u32     InputCount;
+    wire_id Clock;
+    b32     Clocked;
+} benchmark_ports;
+
+typedef void benchmark_builder(u32 Width, benchmark_ports* Ports);
+
+typedef struct
+{
+    string             Name;
+    benchmark_builder* Build;
+} benchmark_workload;
+
+local void BuildFullAdderBenchmark(u32 Width, benchmark_ports* Ports)
+{
+    wires   A     = AddWires(Width);
+    wires   B     = AddWires(Width);
+    wire_id C     = AddWire();
+    wires   Sum   = AddWires(Width);
+    wire_id Carry = AddWire();
+
+    FullAdder(A, B, C, Sum, Carry);
+
+    Ports->Inputs[0]  = A;
+    Ports->Inputs[1]  = B;
+    Ports->Inputs[2]  = (wires){C, 1};
+    Ports->InputCount = 3;
+}
+
+local void BuildALUBenchmark(u32 Width, benchmark_ports* Ports)
+{
+    wires   A          = AddWires(Width);
+    wires   B          = AddWires(Width);
+    wire_id SubtractOp = AddWire();
+    wires   Out        = AddWires(Width);
+    wire_id Carry      = AddWire();
+
+    ALU(A, B, SubtractOp, Out, Carry);
+
+    Ports->Inputs[0]  = A;
+    Ports->Inputs[1]  = B;
+    Ports->Inputs[2]  = (wires){SubtractOp, 1};
+    Ports->InputCount = 3;
+}
+
+local void BuildMuxBenchmark(u32 Width, benchmark_ports* Ports)
+{
+    wires   In     = AddWires(Width);
+    wires   Select = AddWires(FindLowestSetBit(Width));
+    wire_id Out    = AddWire();
+
+    Mux(In, Select, Out);
+
+    Ports->Inputs[0]  = In;
+    Ports->Inputs[1]  = Select;
+    Ports->InputCount = 2;
+}
+
+local void BuildDemuxBenchmark(u32 Width, benchmark_ports* Ports)
+{
+    wire_id In     = AddWire();
+    wires   Select = AddWires(FindLowestSetBit(Width));
+    wires   Out    = AddWires(Width);
+
+    Demux(In, Select, Out);
+
+    Ports->Inputs[0]  = (wires){In, 1};
+    Ports->Inputs[1]  = Select;
+    Ports->InputCount = 2;
+}
+
+local void BuildRegisterBenchmark(u32 Width, benchmark_ports* Ports)
+{
+    wires   Data         = AddWires(Width);
+    wires   WriteEnables = AddWires(BenchmarkRegisterCount);
+    wire_id Clock        = AddWire();
+
+    for (u32 Index = 0; Index < BenchmarkRegisterCount; Index++)
+        Register(Data, WriteEnables.First + Index, Clock, AddWires(Width));
+
+    Ports->Inputs[0]  = Data;
+    Ports->Inputs[1]  = WriteEnables;
+    Ports->InputCount = 2;
+    Ports->Clock      = Clock;
+    Ports->Clocked    = true;
+}
+
+#define BenchmarkWorkload(Name) {{#Name, sizeof(#Name) - 1}, Build##Name##Benchmark}
+
+local benchmark_workload BenchmarkWorkloads[] =
+{
+    BenchmarkWorkload(FullAdder),
+    BenchmarkWorkload(ALU),
+    BenchmarkWorkload(Mux),
+    BenchmarkWorkload(Demux),
+    BenchmarkWorkload(Register),
+};
+
+local u32 BenchmarkWidths[] = {8, 64, 512, 4096}; // NOTE(vak): Powers of two, for the select wires of the multiplexers
+
+local simulation_engine BenchmarkEngines[] =
+{
+    SimulationEngine_Sweep,
+    SimulationEngine_Event,
+    SimulationEngine_Levelized,
+    SimulationEngine_JIT,
+    SimulationEngine_Parallel,
+};
+
+local string GetBenchmarkEngineName(simulation_engine Engine)
+{
+    string Result = {0};
+
+    switch (Engine)
+    {
+        case SimulationEngine_Sweep:     Result = Str("Sweep");     break;
+        case SimulationEngine_Event:     Result = Str("Event");     break;
+        case SimulationEngine_Levelized: Result = Str("Levelized"); break;
+        case SimulationEngine_JIT:       Result = Str("JIT");       break;
+        case SimulationEngine_Parallel:  Result = Str("Parallel");  break;
+
+        InvalidDefaultCase;
+    }
+
+    return (Result);
+}
+
+// NOTE(vak): Measuring
+
+typedef struct
+{
+    u64 Minimum;
+    u64 Median;
+    u64 Mean;
+    u64 Maximum;
+} benchmark_stats;
+
+#define BenchmarkTargetFraction (50) // NOTE(vak): Each repetition runs for about a 50th of a second
+#define BenchmarkSeed           (0x9E3779B97F4A7C15ull)
+
+local benchmark_stats GetBenchmarkStats(u64* Samples)
+{
+    // NOTE(vak): Sorts the samples in place.
+    for (u32 Index = 1; Index < BenchmarkRepetitionCount; Index++)
+    {
+        u64 Sample = Samples[Index];
+        u32 At     = Index;
+
+        for (; At && (Samples[At - 1] > Sample); At--)
+            Samples[At] = Samples[At - 1];
+
+        Samples[At] = Sample;
+    }
+
+    u64 Sum = 0;
+
+    for (u32 Index = 0; Index < BenchmarkRepetitionCount; Index++)
+        Sum += Samples[Index];
+
+    benchmark_stats Result = {0};
+
+    Result.Minimum = Samples[0];
+    Result.Median  = Samples[BenchmarkRepetitionCount / 2];
+    Result.Mean    = Sum / BenchmarkRepetitionCount;
+    Result.Maximum = Samples[BenchmarkRepetitionCount - 1];
+
+    return (Result);
+}
+
+local void RunBenchmarkIterations(benchmark_ports* Ports, b32 Cycles, u32 IterationCount)
+{
+    for (u32 Iteration = 0; Iteration < IterationCount; Iteration++)
+    {
+        for (u32 Index = 0; Index < Ports->InputCount; Index++)
+            RandomWires(Ports->Inputs[Index]);
+
+        if (Cycles)
+            SimulateClockCycle(Ports->Clock, BenchmarkPulseTime);
+        else
+            SimulateCircuit();
+    }
+}
+
+local benchmark_stats MeasureBenchmark(benchmark_ports* Ports, b32 Cycles, u64 WorkCount)
+{
+    // NOTE(vak): Returns picoseconds per unit of work, 'WorkCount' units per iteration. The iterations
+    // of a repetition are calibrated first, which also compiles the circuit for engines that need it.
+    // NOTE(vak): The same stimulus every run.
+    SeedRandom(BenchmarkSeed);
+
+    usize Target = GetWallClockFrequency() / BenchmarkTargetFraction;
+
+    u32   IterationCount = 1;
+    usize Elapsed        = 0;
+
+    for (;;)
+    {
+        usize Start = GetWallClock();
+        RunBenchmarkIterations(Ports, Cycles, IterationCount);
+        Elapsed = GetWallClock() - Start;
+
+        if ((Elapsed >= Target / 8) || (IterationCount >= (1u << 24)))
+            break;
+
+        IterationCount *= 2;
+    }
+
+    IterationCount = (u32)Maximum((u64)IterationCount * Target / Maximum(Elapsed, 1), 1);
+
+    u64 Samples[BenchmarkRepetitionCount];
+
+    for (u32 Repetition = 0; Repetition < BenchmarkRepetitionCount; Repetition++)
+    {
+        usize Start = GetWallClock();
+        RunBenchmarkIterations(Ports, Cycles, IterationCount);
+        usize Ticks = GetWallClock() - Start;
+
+        Samples[Repetition] = GetNanoseconds(Ticks, GetWallClockFrequency()) * 1000 / (IterationCount * WorkCount);
+    }
+
+    benchmark_stats Result = GetBenchmarkStats(Samples);
+    return (Result);
+}
+
+// NOTE(vak): Reporting
+
+local usize PrintBenchmarkNumber(u64 Value, u32 Decimals)
+{
+    char Buffer[MaxNumberTextSize];
+
+    usize Result = Print(FormatNumber(Buffer, Value, Decimals));
+    return (Result);
+}
+
+local void PrintBenchmarkStats(benchmark_stats Stats, u32 Decimals, string Unit)
+{
+    PrintBenchmarkNumber(Stats.Median, Decimals);
+    Print(Str(" "));
+    Print(Unit);
+    Print(Str(" (min "));
+    PrintBenchmarkNumber(Stats.Minimum, Decimals);
+    Print(Str(", mean "));
+    PrintBenchmarkNumber(Stats.Mean, Decimals);
+    Print(Str(", max "));
+    PrintBenchmarkNumber(Stats.Maximum, Decimals);
+    Print(Str(")"));
+}
+
+local void PrintBenchmarkPadding(usize SoFar)
+{
+    if (SoFar < TestResultPrintPadding)
+        PrintRepeat(Str(" "), TestResultPrintPadding - SoFar);
+}
+
+// NOTE(vak): Running
+
+local void RunBenchmark(benchmark_workload* Workload, u32 Width)
+{
+    circuit* Previous = GetCircuit();
+    circuit* Circuit  = CreateCircuit();
+
+    BindCircuit(Circuit);
+
+    // NOTE(vak): Construction, the netlist of the last repetition is kept for its numbers.
+    benchmark_ports Ports = {0};
+
+    u64 BuildSamples[BenchmarkRepetitionCount];
+
+    for (u32 Repetition = 0; Repetition < BenchmarkRepetitionCount; Repetition++)
+    {
+        ResetCircuit();
+
+        benchmark_ports Built = {0};
+
+        usize Start = GetWallClock();
+        Workload->Build(Width, &Built);
+        usize Ticks = GetWallClock() - Start;
+
+        BuildSamples[Repetition] = GetNanoseconds(Ticks, GetWallClockFrequency());
+
+        Ports = Built;
+    }
+
+    circuit_stats Netlist = GetCircuitStats();
+
+    usize SoFar = 0;
+
+    SoFar += Print(Str("["));
+    SoFar += Print(Workload->Name);
+    SoFar += Print(Str(" "));
+    SoFar += PrintBenchmarkNumber(Width, 0);
+    SoFar += Print(Str("]:"));
+
+    PrintBenchmarkPadding(SoFar);
+    PrintBenchmarkNumber(Netlist.GateCount, 0);
+    Print(Str(" gates, "));
+    PrintBenchmarkNumber(Netlist.WireCount, 0);
+    Print(Str(" wires, build "));
+    PrintBenchmarkStats(GetBenchmarkStats(BuildSamples), 3, Str("us"));
+    PrintNewLine();
+
+    BindCircuit(Previous);
+    DestroyCircuit(Circuit);
+
+    // NOTE(vak): Every engine gets a circuit of its own, so that its memory is not shared with the others.
+    for (u32 EngineIndex = 0; EngineIndex < ArrayCount(BenchmarkEngines); EngineIndex++)
+    {
+        simulation_engine Engine = BenchmarkEngines[EngineIndex];
+
+        Circuit = CreateCircuit();
+        BindCircuit(Circuit);
+
+        Workload->Build(Width, &Ports);
+        SetSimulationEngine(Engine);
+
+        u64 GateCount = Maximum(Netlist.GateCount, 1);
+
+        benchmark_stats Passes = MeasureBenchmark(&Ports, false, GateCount);
+        circuit_stats   Stats  = GetCircuitStats();
+
+        SoFar  = Print(Str("    "));
+        SoFar += Print(GetBenchmarkEngineName(Engine));
+        SoFar += Print(Str(":"));
+
+        PrintBenchmarkPadding(SoFar);
+        Print(Str("pass "));
+        PrintBenchmarkStats(Passes, 3, Str("ns/gate"));
+        Print(Str(", "));
+        PrintBenchmarkNumber(1000000000ull / Maximum(Passes.Median, 1), 3);
+        Print(Str(" M gates/s, "));
+        PrintBenchmarkNumber(Stats.CommittedSize * 10 / GateCount, 1);
+        Println(Str(" bytes/gate"));
+
+        if (Ports.Clocked)
+        {
+            benchmark_stats Cycles = MeasureBenchmark(&Ports, true, 1000);
+
+            PrintBenchmarkPadding(0);
+            Print(Str("cycle "));
+            PrintBenchmarkStats(Cycles, 3, Str("us"));
+            PrintNewLine();
+        }
+
+        BindCircuit(Previous);
+        DestroyCircuit(Circuit);
+    }
+}
+
+local void RunBenchmarks(void)
+{
+    for (u32 WorkloadIndex = 0; WorkloadIndex < ArrayCount(BenchmarkWorkloads); WorkloadIndex++)
+    {
+        for (u32 WidthIndex = 0; WidthIndex < ArrayCount(BenchmarkWidths); WidthIndex++)
+            RunBenchmark(BenchmarkWorkloads + WorkloadIndex, BenchmarkWidths[WidthIndex]);
+
+        PrintNewLine();
+    }
+}
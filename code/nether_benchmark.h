@@ -0,0 +1,29 @@
+#pragma once
+
+// NOTE(vak): Benchmarks
+
+// NOTE(vak):
+// Building with 'NETHER_BENCHMARK' set runs the benchmarks instead of the
+// tests. Every workload is built out of the regular builders at several
+// widths, then timed on every engine:
+// - Construction, from an empty circuit until the builder returns.
+// - Single passes, 'SimulateCircuit' with fresh random inputs each time.
+// - Clock cycles, 'SimulateClockCycle' with fresh random inputs each time,
+//   for the workloads that have a clock.
+// Each measurement is repeated 'BenchmarkRepetitionCount' times, and each
+// repetition runs long enough for the wall clock to be meaningful.
+// Reported are the median with the minimum, mean and maximum of the
+// repetitions. Gate counts have every module instance expanded, so the
+// rate of an engine that skips gates (the event engine) is an effective
+// one rather than the number of gates it really evaluated. Bytes per gate
+// is everything the circuit committed, engine included, over that count.
+
+#ifndef NETHER_BENCHMARK
+#define NETHER_BENCHMARK 0
+#endif
+
+#define BenchmarkRepetitionCount (5)
+#define BenchmarkPulseTime       (16)
+#define BenchmarkRegisterCount   (8) // NOTE(vak): Registers in a bank, they share the data and clock wires
+
+local void RunBenchmarks(void);
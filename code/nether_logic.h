@@ -10,17 +10,81 @@ typedef struct
     u32     Count;
 } wires;
 
+typedef u64 lanes; // NOTE(vak): One bit per lane, every lane is an independent stimulus vector
+
+#define LaneWordCount (8)
+#define LaneCount     (64 * LaneWordCount)
+
+typedef enum
+{
+    LaneKernel_Unknown = 0,
+
+    LaneKernel_Scalar,
+    LaneKernel_AVX2,
+    LaneKernel_AVX512,
+} lane_kernel;
+
+typedef enum
+{
+    SimulationEngine_Sweep = 0, // NOTE(vak): Evaluates every gate in order on every pass
+    SimulationEngine_Event,     // NOTE(vak): Only evaluates the gates whose wires changed since their last evaluation
+    SimulationEngine_Levelized, // NOTE(vak): Evaluates gates in dependency order and iterates feedback loops until they settle
+    SimulationEngine_JIT,       // NOTE(vak): Runs the levelized schedule as generated x86-64 machine code
+    SimulationEngine_Parallel,  // NOTE(vak): Runs the levelized schedule on a pool of threads, level by level
+} simulation_engine;
+
 // NOTE(vak): Circuit
 
+// NOTE(vak):
+// Every function below works on the circuit bound to the calling thread,
+// and a thread that has not bound one gets a circuit of its own on first
+// use. Independent circuits can be built and simulated on different
+// threads at the same time, as long as each is used by one thread at a
+// time.
+typedef struct circuit circuit;
+
+local circuit* CreateCircuit (void);
+local void     DestroyCircuit(circuit* Circuit);
+local void     BindCircuit   (circuit* Circuit); // NOTE(vak): 0 unbinds the current one
+local circuit* GetCircuit    (void);
+
+// NOTE(vak):
+// The sweep and event engines produce exactly the same wire state after
+// every pass. The levelized, JIT and parallel engines settle the circuit
+// within a single pass instead, so they match them once they settled.
+// Engines that need a compiled form of the netlist (re)build it on the
+// first pass after the netlist changed.
+local void              SetSimulationEngine(simulation_engine Engine);
+local simulation_engine GetSimulationEngine(void);
+
+local void SetSimulationThreadCount(u32 ThreadCount); // NOTE(vak): For the parallel engine and 'VerifyExhaustive', 0 means one per processor
+local u32  GetSimulationThreadCount(void);
+
 local void RandomizeWireState(void);
 
 local void ResetCircuit      (void);
 local void ResetGate         (void);
-local void SimulateCircuit   (void);
+local b32  SimulateCircuit   (void); // NOTE(vak): Returns whether any wire changed
+
+// NOTE(vak):
+// Passes stop as soon as one changes nothing, or, for the engines that
+// settle within a single pass, as soon as no feedback loop oscillated.
+// A clock pulse takes at most 'PulseTime' passes.
+local b32 SimulateUntilStable(u32 MaxPasses);                 // NOTE(vak): Returns whether the circuit settled
+local u32 GetToggledWires    (wire_id* Wires, u32 MaxCount); // NOTE(vak): Wires still toggling if it did not, returns how many there are
 
 local void SimulateClockPulse(wire_id Clock, u32 PulseTime);
 local void SimulateClockCycle(wire_id Clock, u32 PulseTime);
 
+typedef struct
+{
+    u32   WireCount;
+    u32   GateCount;     // NOTE(vak): With every module instance expanded, as many as a sweep evaluates per pass
+    usize CommittedSize; // NOTE(vak): Bytes committed for the circuit, including what its engine compiled so far
+} circuit_stats;
+
+local circuit_stats GetCircuitStats(void);
+
 // NOTE(vak): Wires
 
 local wire_id AddWire   (void);
@@ -35,6 +99,234 @@ local void    SetWires   (wires Wires, u64 Bits);
 local b32     ExpectWires(wires Wires, u64 ExpectedBits);
 local void    RandomWires(wires Wires);
 
+// NOTE(vak): Random numbers
+// Every circuit has a stream of random numbers of its own, which the
+// random wire and lane functions draw from as well. The streams are
+// seeded from the seed of the run and the order the circuits were created
+// in, so building with 'NETHER_RANDOM_SEED' set to the seed a failed test
+// printed runs the same stimulus again. Without it, the seed of the run
+// comes from the wall clock.
+
+#ifndef NETHER_RANDOM_SEED
+#define NETHER_RANDOM_SEED 0
+#endif
+
+local u64  GetRandomSeed(void);     // NOTE(vak): Of the run
+local void SeedRandom   (u64 Seed); // NOTE(vak): Restarts the stream of the circuit
+local u64  RandomBits   (void);     // NOTE(vak): 64 bits from the stream of the circuit
+
+// NOTE(vak): Ports
+// Names for the wires a circuit is driven and read through, so that a
+// circuit loaded from a file can be used without the code that built it.
+
+local void AddPort (wires Wires, string Name);   // NOTE(vak): Names have to be unique
+local b32  FindPort(string Name, wires* Wires); // NOTE(vak): Returns whether there is a port of that name, an empty range otherwise
+
+// NOTE(vak): Snapshots
+// Writes the netlist and the wire state to a file, and maps it back in
+// place of the current circuit, see 'Netlists' below. Memories and ports
+// are part of it, lanes are not. Modules are saved expanded, and the
+// simulation engine and builder options stay as they are.
+
+local b32 SaveSnapshot(string Path); // NOTE(vak): Returns whether the file could be written
+local b32 LoadSnapshot(string Path); // NOTE(vak): Returns whether the file was a valid snapshot, the circuit is empty if not
+
+// NOTE(vak): Netlists
+// A snapshot without state: a circuit built once can be saved after
+// construction and loaded instead of built again, and loads as if it had
+// just been built, with every wire but the constant ones and every memory
+// cleared. All sizes and offsets are in bytes, little-endian.
+//
+//     Header, 120 bytes:
+//         u32 Magic                "NETL" (0x4C54454E), snapshots have "SNAP"
+//         u32 Version              1
+//         u32 GateSize             Bytes per gate, the file is refused if it differs
+//         u32 WordGateSize         Bytes per word gate, same
+//         u32 WireCount
+//         u32 GateCount            With every module instance expanded
+//         u32 WordGateCount
+//         u32 MemoryCount
+//         u32 PortCount
+//         u32 PortNameSize
+//         u64 Offsets[9]           Of the sections below, each a multiple of 64
+//         u64 Size                 Of the whole file
+//
+//     Sections, each the raw array the circuit keeps in memory:
+//         Wire state               Empty in a netlist, 1 bit per wire in a snapshot
+//         Observable wires         1 bit per wire, in u64 words
+//         Constant wires           1 bit per wire, in u64 words
+//         Constant values          1 bit per wire, in u64 words
+//         Gates                    'GateCount' gates
+//         Word gates               'WordGateCount' word gates
+//         Memory bytes             Empty in a netlist, 256 bytes per memory in a snapshot
+//         Ports                    'PortCount' times: u32 First wire, u32 wire Count, u32 Name offset, u32 Name size
+//         Port names               'PortNameSize' bytes, not terminated
+//
+// The file is mapped rather than read: the circuit uses the gates, word
+// gates, memories and ports where they are in the file, copied on write,
+// and only copies the wire bits. So the only cost of a load beyond the
+// page faults is checking that every gate and port stays within the
+// circuit. The file stays open until the circuit adds a gate, word gate,
+// memory or port, is saved, reset or destroyed, or loads another file.
+
+local b32 SaveNetlist(string Path); // NOTE(vak): Returns whether the file could be written
+local b32 LoadNetlist(string Path); // NOTE(vak): Returns whether the file was a valid netlist, the circuit is empty if not
+
+// NOTE(vak): Import
+// Adds a gate-level netlist written by another tool to the circuit,
+// lowered to the gates the builder options call for. Every input and
+// output becomes a port of the same name, a vector a single port with
+// its lowest bit first. The file is read as a stream and every wire is
+// added at once, so large benchmark netlists load in about the time it
+// takes to read them.
+//
+// BLIF: the first model's '.inputs', '.outputs', '.names' and '.latch'.
+// Edge-triggered latches become 'DFlipFlop's, which take the data when
+// the clock falls, so 're' ones get an inverted clock. Level-sensitive
+// ones become 'DLatch'es, and asynchronous ones are not supported. The
+// ones without a clock of their own share an input port named "clock",
+// and initial values of 0 and 1 are set on the latch.
+//
+// Verilog: a single module of 'input', 'output' and 'wire' declarations
+// (scalars or vectors), the primitives 'and', 'nand', 'or', 'nor', 'xor',
+// 'xnor', 'not' and 'buf' with any number of inputs, 'dff (Clock, Out,
+// Data)' as in the ISCAS-89 netlists, and 'assign' of single bits with
+// '~', '&', '^', '~^' and '|', and parentheses and '~' nested up to 1024
+// deep.
+//
+// In both, a net driven more than once is not supported.
+
+local b32 ImportBLIF   (string Path); // NOTE(vak): Returns whether the file could be read and is supported, nothing is added if not
+local b32 ImportVerilog(string Path); // NOTE(vak): Same
+
+// NOTE(vak): Tracing
+// Writes the traced wires to a VCD file while the circuit is simulated,
+// one time step per simulation pass, and only the values that changed.
+// A thread of its own writes the file, so tracing costs the simulation
+// little more than comparing the traced wires with the previous pass.
+// Wires are traced until 'StopTrace', or until the circuit is reset.
+
+local void TraceWire (wire_id ID, string Name);
+local void TraceWires(wires Wires, string Name); // NOTE(vak): Up to 64 wires, shown as a single bus
+
+local b32 StartTrace(string Path); // NOTE(vak): Returns whether the file could be created, nothing can be traced while it runs
+local b32 StopTrace (void);        // NOTE(vak): Returns whether everything could be written
+
+// NOTE(vak): Counters
+// Building with 'NETHER_COUNTERS' set makes every circuit count what its
+// simulation does: gate evaluations by kind, passes and the wires each
+// pass changed, passes per clock pulse, wires that 'SetWire'/'SetWires'
+// changed, and the calls to and time spent in the simulation and wire
+// functions, including the functions they call. Comparing evaluations
+// with changed wires shows how much is evaluated for nothing, and time
+// per evaluation shows what each one costs. Without it, none of this is
+// compiled in. Counting starts when the circuit is created.
+
+#ifndef NETHER_COUNTERS
+#define NETHER_COUNTERS 0
+#endif
+
+local void ResetCounters(void);
+local void PrintCounters(void); // NOTE(vak): Only says that there are none without 'NETHER_COUNTERS'
+
+// NOTE(vak): Builder options
+// Apply to everything built afterwards. A module is defined again for
+// every set of options it is used with.
+
+typedef enum
+{
+    BuilderOption_NativeMemory = (1 << 0), // NOTE(vak): Latches and flip-flops hold their bit in a tri-state instead of cross-coupled NANDs
+    BuilderOption_NativeGates  = (1 << 1), // NOTE(vak): Logic gates and multiplexers are single gates instead of NANDs
+    BuilderOption_WordGates    = (1 << 2), // NOTE(vak): Adders, the ALU, comparators and word multiplexers are single word gates
+} builder_option;
+
+// NOTE(vak):
+// A word gate evaluates up to 64 bits at once with integer arithmetic,
+// and drives the same wires as the gates it stands for, so a block can be
+// built at word level or at gate level without changing anything around
+// it. Build everything with word gates, and turn the option off around
+// the block under study. Modules always get gate level, since their
+// ports are bound one wire at a time.
+
+// NOTE(vak):
+// Whether circuits build native gates unless told otherwise. 0 lowers
+// every logic gate to NANDs, the way the hardware would be built, 1
+// trades that for fewer gates and fewer logic levels.
+#ifndef NETHER_NATIVE_GATES
+#define NETHER_NATIVE_GATES 0
+#endif
+
+#if NETHER_NATIVE_GATES
+#define DefaultBuilderOptions (BuilderOption_NativeGates)
+#else
+#define DefaultBuilderOptions (0)
+#endif
+
+local void SetBuilderOptions(u32 Options);
+local u32  GetBuilderOptions(void);
+
+// NOTE(vak): Modules
+// A module is built once per circuit: its builder runs on placeholder
+// ports, and the gates it adds become a template. An instance only stores
+// the wires its ports are bound to, plus private wires of its own. The
+// sweep engine evaluates instances from the template, the other engines
+// expand them into the netlist they compile.
+
+typedef u32  module_id;
+typedef void module_builder(wires Ports);
+
+local module_id DefineModule(module_builder* Builder, u32 PortCount); // NOTE(vak): Later calls return the same module
+local void      AddInstance (module_id Module, wire_id* Ports);      // NOTE(vak): One wire per port
+
+// NOTE(vak): Optimizer
+// Rewrites the netlist into a smaller one: buffers are forwarded,
+// inverter pairs cancelled, constants folded, and gates that do not lead
+// to an observable wire removed. Gates in feedback loops are only
+// rewired, and word gates are kept as they are. Only observable wires
+// are guaranteed to hold their settled value afterwards, the others may
+// be stale. Wire IDs stay the same.
+
+local void MarkObservable (wires Wires);
+local void MarkConstant   (wire_id ID, wire Bit); // NOTE(vak): For inputs that are tied to a fixed value
+local u32  OptimizeCircuit(void);                 // NOTE(vak): Returns the number of gates removed
+
+// NOTE(vak):
+// Replaces the latches 'DLatch' builds out of NANDs, in the netlist and
+// in every module template, with the ones 'BuilderOption_NativeMemory'
+// builds: a tri-state that passes 'Data' while 'Enable' is high, plus an
+// inverter for 'NotOut' when something reads it. A flip-flop then takes
+// 4 gates instead of 11, none of them in a feedback loop. Only latches
+// whose inner wires are read by nothing else are replaced.
+local u32 RecognizeLatches(void); // NOTE(vak): Returns the number of latches replaced
+
+// NOTE(vak): Lanes
+// Every wire holds 'LaneCount' bits (stored as 'LaneWordCount' words),
+// so a single pass evaluates 'LaneCount' stimulus vectors at once. Bus
+// values are exchanged as arrays of 'LaneCount' values, one per lane.
+// The kernel used for a pass only affects speed, never results.
+
+local lane_kernel GetWidestLaneKernel(void);
+local lane_kernel GetLaneKernel      (void);
+local void        SetLaneKernel      (lane_kernel Kernel);
+
+local void  RandomizeLaneState  (void);
+local void  SimulateCircuitLanes(void);
+
+local void  SimulateClockPulseLanes(wire_id Clock, u32 PulseTime);
+local void  SimulateClockCycleLanes(wire_id Clock, u32 PulseTime);
+
+local lanes GetLanes      (wire_id ID, u32 Word);
+local void  SetLanes      (wire_id ID, u32 Word, lanes Bits);
+local b32   ExpectLanes   (wire_id ID, u32 Word, lanes ExpectedBits);
+local void  RandomLanes   (wire_id ID);
+local wire  GetLane       (wire_id ID, u32 Lane);
+local void  BroadcastLanes(wire_id ID, wire Bit);
+
+local void  GetWiresLanes   (wires Wires, u64* Values);
+local void  SetWiresLanes   (wires Wires, u64* Values);
+local b32   ExpectWiresLanes(wires Wires, u64* ExpectedValues);
+local void  RandomWiresLanes(wires Wires);
+
 // NOTE(vak): Buffer
 
 local void BUF(wire_id Input, wire_id Output);
@@ -62,8 +354,10 @@ local void ORx1 (wires In, wire_id Out);
 
 // NOTE(vak): Multiplexer
 
-local void Mux  (wires In, wires Select, wire_id Out);
-local void Demux(wire_id In, wires Select, wires Out);
+local void Mux2  (wire_id A, wire_id B, wire_id Select, wire_id Out); // NOTE(vak): Out = Select ? B : A
+local void Mux2xN(wires A, wires B, wire_id Select, wires Out);
+local void Mux   (wires In, wires Select, wire_id Out);
+local void Demux (wire_id In, wires Select, wires Out);
 
 // NOTE(vak): Adder
 
@@ -73,6 +367,11 @@ local void FullAdder1(wire_id A, wire_id B, wire_id C, wire_id Sum, wire_id Carr
 local void HalfAdder(wires A, wires B,            wires Sum, wire_id Carry);
 local void FullAdder(wires A, wires B, wire_id C, wires Sum, wire_id Carry);
 
+// NOTE(vak): Comparator
+// Equal = (A == B)
+// Less  = (A < B), unsigned
+local void Comparator(wires A, wires B, wire_id Equal, wire_id Less);
+
 // NOTE(vak): Memory
 
 // NOTE(vak):
@@ -103,9 +402,18 @@ local void ALU(wires A, wires B, wire_id SubtractOp, wires Out, wire_id Carry);
 // If `ChipEnable` is 1:
 //     If `WriteEnable` is 0: Data8 = Bytes[Address8]
 //     If `WriteEnable` is 1: Bytes[Address8] = Data8
+// Otherwise `Data8` is left to whatever else drives it.
 // Minimum read  time: 1
 // Minimum write time: 2
-local void RAM256(wires Address8, wires Data8, wire_id WriteEnable, wire_id ChipEnable);
+// The bytes start out cleared, every lane has its own copy of them, and
+// the memory cannot be part of a module.
+typedef u32 memory_id;
+
+local memory_id RAM256(wires Address8, wires Data8, wire_id WriteEnable, wire_id ChipEnable);
+
+local void LoadMemory    (memory_id Memory, u32 Address, u8* Bytes, u32 Count); // NOTE(vak): Into every lane as well
+local void DumpMemory    (memory_id Memory, u32 Address, u8* Bytes, u32 Count);
+local void DumpMemoryLane(memory_id Memory, u32 Lane, u32 Address, u8* Bytes, u32 Count);
 
 // NOTE(vak): Testing
 
@@ -116,11 +424,33 @@ local b32 VerifyTruthTable(
     wires Inputs, wires Outputs
 );
 
+// NOTE(vak):
+// Checks 'Outputs' against 'Reference' for every combination of 'Inputs',
+// with the first wire of each in bit 0. Every lane pass checks
+// 'LaneCount' combinations, whose counting patterns are written straight
+// into the lanes, and chunks of the combinations are spread over
+// 'GetSimulationThreadCount' threads, every other thread on a copy of the
+// circuit. 24 inputs take 32768 lane passes in all. Like
+// 'VerifyTruthTable', a combination gets a single lane pass, so the block
+// has to be combinational with every gate added after the gates it reads,
+// the way the builders add them. 'Reference' is called from several
+// threads at once.
+#define MaxExhaustiveInputCount (40)
+
+typedef u64 reference_function(u64 Inputs); // NOTE(vak): Returns the expected outputs
+
+local b32 VerifyExhaustive(wires Inputs, wires Outputs, reference_function* Reference, u64* FailedInputs); // NOTE(vak): 'FailedInputs', unless 0, gets a combination that failed
+
 local void OutputTestResult(string Name, b32 Successful);
 
+local void TestWires(void);
+local void TestStorage(void);
+local void TestRandom(void);
+local void TestCircuits(void);
 local void TestBUF(void);
 local void TestTriState(void);
 local void TestLogicGates(void);
+local void TestNativeGates(void);
 
 local void TestMUXx1(void);
 
@@ -131,6 +461,25 @@ local void TestFullAdder(void);
 
 local void TestDLatch(void);
 local void TestDFlipFlop(void);
+local void TestNativeMemory(void);
 
 local void TestRegister(void);
 local void TestALU(void);
+local void TestWordGates(void);
+local void TestRAM256(void);
+local void TestTrace(void);
+local void TestSnapshot(void);
+local void TestNetlist(void);
+local void TestImport(void);
+local void TestModules(void);
+
+#if NETHER_COUNTERS
+local void TestCounters(void);
+#endif
+
+local void TestLaneKernels(void);
+local void TestExhaustive(void);
+
+local void TestSimulationEngines(void);
+local void TestUntilStable(void);
+local void TestOptimizer(void);
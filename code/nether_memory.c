@@ -0,0 +1,56 @@
+// NOTE(vak): Arena
+
+local void* CommitArena(arena* Arena, usize Size)
+{
+    if (Size > Arena->ReservedSize)
+    {
+        usize ReservedSize = (Size + ArenaReserveGranularity - 1) & ~(usize)(ArenaReserveGranularity - 1);
+
+        ReservedSize = Maximum(ReservedSize, 2 * Arena->ReservedSize);
+
+        u8* Base = ReserveMemory(ReservedSize);
+        Assert(Base);
+
+        if (Arena->CommittedSize)
+        {
+            b32 Successful = CommitMemory(Base, Arena->CommittedSize);
+            Assert(Successful);
+
+            // NOTE(vak): Committed sizes are a multiple of the commit granularity, so this copies whole words.
+            u64* Source      = (u64*)Arena->Base;
+            u64* Destination = (u64*)Base;
+
+            for (usize Index = 0; Index < Arena->CommittedSize / sizeof(u64); Index++)
+                Destination[Index] = Source[Index];
+
+            ReleaseMemory(Arena->Base, Arena->ReservedSize);
+        }
+
+        Arena->Base         = Base;
+        Arena->ReservedSize = ReservedSize;
+    }
+
+    if (Size > Arena->CommittedSize)
+    {
+        usize CommittedSize = (Size + ArenaCommitGranularity - 1) & ~(usize)(ArenaCommitGranularity - 1);
+
+        CommittedSize = Minimum(CommittedSize, Arena->ReservedSize);
+
+        b32 Successful = CommitMemory(Arena->Base + Arena->CommittedSize, CommittedSize - Arena->CommittedSize);
+        Assert(Successful);
+
+        Arena->CommittedSize = CommittedSize;
+    }
+
+    return (Arena->Base);
+}
+
+local void ReleaseArena(arena* Arena)
+{
+    if (Arena->Base)
+        ReleaseMemory(Arena->Base, Arena->ReservedSize);
+
+    Arena->Base          = 0;
+    Arena->ReservedSize  = 0;
+    Arena->CommittedSize = 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// NOTE(vak): Arena
+// A contiguous range of address space that is committed as it grows.
+// When it outgrows its reservation, it moves to one twice as large, so
+// pointers into it are only valid until the next commit.
+
+#define ArenaReserveGranularity (64 * 1024)
+#define ArenaCommitGranularity  (4 * 1024)
+
+typedef struct
+{
+    u8*   Base;
+    usize ReservedSize;
+    usize CommittedSize;
+} arena;
+
+local void* CommitArena (arena* Arena, usize Size); // NOTE(vak): Makes the first 'Size' bytes usable, returns the base address
+local void  ReleaseArena(arena* Arena);
@@ -1,7 +1,42 @@
 
 #pragma once
 
-local usize GetWallClock(void);
+local usize GetWallClock         (void);
+local usize GetWallClockFrequency(void); // NOTE(vak): Ticks of 'GetWallClock' per second
+
+local void* ReserveMemory(usize Size);              // NOTE(vak): Address space only, inaccessible until committed
+local b32   CommitMemory (void* Memory, usize Size); // NOTE(vak): Readable, writable and zeroed
+local void  ReleaseMemory(void* Memory, usize Size);
+
+typedef u32 thread_proc(void* Parameter);
+
+local u32  GetProcessorCount(void);
+local void StartThread      (thread_proc* Procedure, void* Parameter);
+local void YieldThread      (void);
+
+local u32   AllocateThreadSlot(void); // NOTE(vak): Holds one pointer per thread, 0 until set
+local void  FreeThreadSlot    (u32 Slot);
+local void* GetThreadSlot     (u32 Slot);
+local void  SetThreadSlot     (u32 Slot, void* Value);
+
+local void* NewSemaphore (void);
+local void  FreeSemaphore(void* Semaphore);
+local void  WaitSemaphore(void* Semaphore);
+local void  PostSemaphore(void* Semaphore, u32 Count);
+
+local void* OpenInputFile   (string Path);                        // NOTE(vak): 0 if it cannot be opened
+local void* OpenOutputFile  (string Path);                        // NOTE(vak): Created, or emptied if it exists, 0 if it cannot be
+local u64   GetInputFileSize(void* File);
+local usize ReadFromFile    (void* File, void* Data, usize Size); // NOTE(vak): Returns how many bytes were read, fewer only at the end of the file
+local b32   WriteToFile     (void* File, void* Data, usize Size);
+local void  CloseFile       (void* File);
+local b32   RemoveFile      (string Path);
+local void* MapFile         (void* File, u64 Size);               // NOTE(vak): A private view of an input file, copied on write, 0 if it cannot be mapped
+local void  UnmapFile       (void* Memory, u64 Size);
+
+local void* AllocateCodeMemory(usize Size); // NOTE(vak): Readable and writable, until made executable
+local void  MakeCodeExecutable(void* Memory, usize Size);
+local void  FreeCodeMemory    (void* Memory, usize Size);
 
 local usize Print       (string Message);
 local usize Println     (string Message);
@@ -1,2 +1,62 @@
 
 
+
+// NOTE(vak): Bit manipulation
+
+local u32 FindLowestSetBit(u64 Value)
+{
+    Assert(Value != 0);
+
+    unsigned long Result = 0;
+    _BitScanForward64(&Result, Value);
+
+    return ((u32)Result);
+}
+
+local u32 CountSetBits(u64 Value)
+{
+    u32 Result = (u32)__popcnt64(Value);
+    return (Result);
+}
+
+// NOTE(vak): String
+
+local b32 StringsAreEqual(string A, string B)
+{
+    b32 Result = (A.Size == B.Size);
+
+    for (usize Index = 0; Result && (Index < A.Size); Index++)
+        Result = (A.Data[Index] == B.Data[Index]);
+
+    return (Result);
+}
+
+// NOTE(vak): Numbers
+
+local string FormatNumber(char* Buffer, u64 Value, u32 Decimals)
+{
+    Assert(Decimals < MaxNumberTextSize - 21);
+
+    // NOTE(vak): Digits come out least significant first, so they are written from the end of the buffer.
+    usize At = MaxNumberTextSize;
+
+    do
+    {
+        if (Decimals && (At == MaxNumberTextSize - Decimals))
+            Buffer[--At] = '.';
+
+        Buffer[--At] = (char)('0' + (Value % 10));
+        Value /= 10;
+    }
+    while (Value || (At > MaxNumberTextSize - Decimals - 1));
+
+    string Result = StrData(Buffer + At, MaxNumberTextSize - At);
+    return (Result);
+}
+
+local u64 GetNanoseconds(u64 Ticks, u64 Frequency)
+{
+    // NOTE(vak): Whole seconds first, so the product does not overflow.
+    u64 Result = (Ticks / Frequency) * 1000000000ull + (Ticks % Frequency) * 1000000000ull / Frequency;
+    return (Result);
+}
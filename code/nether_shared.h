@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <intrin.h>
+
 // NOTE(vak): Keywords
 
 #define local   static // NOTE(vak): Function/variable is only visible within the current translation unit
@@ -66,6 +68,11 @@ typedef u64 b64;
 #define U32Max ((u32)(4294967295ull))
 #define U64Max ((u64)(18446744073709551615ull))
 
+// NOTE(vak): Bit manipulation
+
+local u32 FindLowestSetBit(u64 Value); // NOTE(vak): 'Value' must not be 0
+local u32 CountSetBits    (u64 Value);
+
 // NOTE(vak): String
 
 typedef struct
@@ -76,3 +83,12 @@ typedef struct
 
 #define Str(Literal)        (string){Literal, sizeof(Literal) - 1}
 #define StrData(Data, Size) (string){Data, Size}
+
+local b32 StringsAreEqual(string A, string B);
+
+// NOTE(vak): Numbers
+
+#define MaxNumberTextSize (32)
+
+local string FormatNumber(char* Buffer, u64 Value, u32 Decimals); // NOTE(vak): 'Value' is in units of 10^-'Decimals', 'Buffer' holds 'MaxNumberTextSize' characters
+local u64    GetNanoseconds(u64 Ticks, u64 Frequency);             // NOTE(vak): 'Frequency' is in ticks per second
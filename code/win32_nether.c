@@ -4,15 +4,36 @@
 
 #include "nether_platform.h"
 
+#include "nether_memory.h"
+#include "nether_memory.c"
+
 #include "nether_logic.h"
 #include "nether_logic.c"
 
+#include "nether_benchmark.h"
+#include "nether_benchmark.c"
+
 #include "nether.h"
 #include "nether.c"
 
 #include "win32_nether.h"
 #include "win32_platform.c"
 
+// NOTE(vak): There is no CRT to link against, but an optimizing build turns some loops and copies into calls to these.
+#pragma function(memset)
+void* __cdecl memset(void* Destination, int Value, size_t Size)
+{
+    __stosb((unsigned char*)Destination, (unsigned char)Value, Size);
+    return (Destination);
+}
+
+#pragma function(memcpy)
+void* __cdecl memcpy(void* Destination, const void* Source, size_t Size)
+{
+    __movsb((unsigned char*)Destination, (const unsigned char*)Source, Size);
+    return (Destination);
+}
+
 local void Win32SetupConsole(void)
 {
     HANDLE StdOut = GetStdHandle(STD_OUTPUT_HANDLE);
@@ -8,6 +8,256 @@ local usize GetWallClock(void)
     return (Result);
 }
 
+local usize GetWallClockFrequency(void)
+{
+    LARGE_INTEGER Frequency = {0};
+    QueryPerformanceFrequency(&Frequency);
+
+    usize Result = Frequency.QuadPart;
+    return (Result);
+}
+
+local u32 GetProcessorCount(void)
+{
+    SYSTEM_INFO Info;
+    GetSystemInfo(&Info);
+
+    u32 Result = Info.dwNumberOfProcessors;
+    return (Result);
+}
+
+local void StartThread(thread_proc* Procedure, void* Parameter)
+{
+    HANDLE Thread = CreateThread(0, 0, (LPTHREAD_START_ROUTINE)Procedure, Parameter, 0, 0);
+    Assert(Thread);
+
+    CloseHandle(Thread);
+}
+
+local void YieldThread(void)
+{
+    SwitchToThread();
+}
+
+local u32 AllocateThreadSlot(void)
+{
+    u32 Result = TlsAlloc();
+    Assert(Result != TLS_OUT_OF_INDEXES);
+
+    return (Result);
+}
+
+local void FreeThreadSlot(u32 Slot)
+{
+    TlsFree(Slot);
+}
+
+local void* GetThreadSlot(u32 Slot)
+{
+    void* Result = TlsGetValue(Slot);
+    return (Result);
+}
+
+local void SetThreadSlot(u32 Slot, void* Value)
+{
+    TlsSetValue(Slot, Value);
+}
+
+local void* NewSemaphore(void)
+{
+    HANDLE Result = CreateSemaphoreA(0, 0, S32Max, 0);
+    Assert(Result);
+
+    return (Result);
+}
+
+local void FreeSemaphore(void* Semaphore)
+{
+    CloseHandle(Semaphore);
+}
+
+local void WaitSemaphore(void* Semaphore)
+{
+    WaitForSingleObject(Semaphore, INFINITE);
+}
+
+local void PostSemaphore(void* Semaphore, u32 Count)
+{
+    ReleaseSemaphore(Semaphore, Count, 0);
+}
+
+local void* ReserveMemory(usize Size)
+{
+    void* Result = VirtualAlloc(0, Size, MEM_RESERVE, PAGE_NOACCESS);
+    return (Result);
+}
+
+local b32 CommitMemory(void* Memory, usize Size)
+{
+    b32 Result = (VirtualAlloc(Memory, Size, MEM_COMMIT, PAGE_READWRITE) != 0);
+    return (Result);
+}
+
+local void ReleaseMemory(void* Memory, usize Size)
+{
+    VirtualFree(Memory, 0, MEM_RELEASE);
+}
+
+local b32 Win32GetPath(string Path, char* Buffer, usize BufferSize)
+{
+    // NOTE(vak): Win32 wants a null-terminated path.
+
+    b32 Result = (Path.Size < BufferSize);
+
+    if (Result)
+    {
+        for (usize Index = 0; Index < Path.Size; Index++)
+            Buffer[Index] = Path.Data[Index];
+
+        Buffer[Path.Size] = 0;
+    }
+
+    return (Result);
+}
+
+local void* OpenInputFile(string Path)
+{
+    void* Result = 0;
+
+    char Buffer[MAX_PATH];
+
+    if (Win32GetPath(Path, Buffer, sizeof(Buffer)))
+    {
+        HANDLE File = CreateFileA(Buffer, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+
+        if (File != INVALID_HANDLE_VALUE)
+            Result = File;
+    }
+
+    return (Result);
+}
+
+local void* OpenOutputFile(string Path)
+{
+    void* Result = 0;
+
+    char Buffer[MAX_PATH];
+
+    if (Win32GetPath(Path, Buffer, sizeof(Buffer)))
+    {
+        HANDLE File = CreateFileA(Buffer, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+
+        if (File != INVALID_HANDLE_VALUE)
+            Result = File;
+    }
+
+    return (Result);
+}
+
+local u64 GetInputFileSize(void* File)
+{
+    LARGE_INTEGER Size = {0};
+
+    u64 Result = (GetFileSizeEx(File, &Size)) ? ((u64)Size.QuadPart) : (0);
+    return (Result);
+}
+
+local usize ReadFromFile(void* File, void* Data, usize Size)
+{
+    usize Result = 0;
+
+    while (Result < Size)
+    {
+        DWORD BytesToRead = (DWORD)Minimum(Size - Result, U32Max);
+        DWORD BytesRead   = 0;
+
+        if (!ReadFile(File, (u8*)Data + Result, BytesToRead, &BytesRead, 0) || (BytesRead == 0))
+            break;
+
+        Result += BytesRead;
+    }
+
+    return (Result);
+}
+
+local b32 WriteToFile(void* File, void* Data, usize Size)
+{
+    usize Written = 0;
+
+    while (Written < Size)
+    {
+        DWORD BytesToWrite = (DWORD)Minimum(Size - Written, U32Max);
+        DWORD BytesWritten = 0;
+
+        if (!WriteFile(File, (u8*)Data + Written, BytesToWrite, &BytesWritten, 0) || (BytesWritten == 0))
+            break;
+
+        Written += BytesWritten;
+    }
+
+    b32 Result = (Written == Size);
+    return (Result);
+}
+
+local void CloseFile(void* File)
+{
+    CloseHandle(File);
+}
+
+local b32 RemoveFile(string Path)
+{
+    b32 Result = false;
+
+    char Buffer[MAX_PATH];
+
+    if (Win32GetPath(Path, Buffer, sizeof(Buffer)))
+        Result = DeleteFileA(Buffer);
+
+    return (Result);
+}
+
+local void* MapFile(void* File, u64 Size)
+{
+    void* Result = 0;
+
+    HANDLE Mapping = CreateFileMappingA(File, 0, PAGE_WRITECOPY, 0, 0, 0);
+
+    if (Mapping)
+    {
+        // NOTE(vak): The view keeps the mapping alive.
+        Result = MapViewOfFile(Mapping, FILE_MAP_COPY, 0, 0, (SIZE_T)Size);
+        CloseHandle(Mapping);
+    }
+
+    return (Result);
+}
+
+local void UnmapFile(void* Memory, u64 Size)
+{
+    UnmapViewOfFile(Memory);
+}
+
+local void* AllocateCodeMemory(usize Size)
+{
+    void* Result = VirtualAlloc(0, Size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    return (Result);
+}
+
+local void MakeCodeExecutable(void* Memory, usize Size)
+{
+    DWORD OldProtection = 0;
+
+    BOOL Successful = VirtualProtect(Memory, Size, PAGE_EXECUTE_READ, &OldProtection);
+    Assert(Successful);
+
+    FlushInstructionCache(GetCurrentProcess(), Memory, Size);
+}
+
+local void FreeCodeMemory(void* Memory, usize Size)
+{
+    VirtualFree(Memory, 0, MEM_RELEASE);
+}
+
 local usize Print(string Message)
 {
     usize Result = 0;